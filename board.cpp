@@ -0,0 +1,421 @@
+#include "board.h"
+
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <stdexcept>
+
+Command parseCommand(const std::string& msg) {
+    size_t space = msg.find(' ');
+    if (space == std::string::npos) {
+        return Command{msg, ""};
+    }
+    return Command{msg.substr(0, space), msg.substr(space + 1)};
+}
+
+BulletinBoard::BulletinBoard(Transport& transport) : transport(transport) {
+    // Initialize groups with IDs
+    for (int id = 1; id <= 5; id++) {
+        Group& group = groups[id];
+        group.id = id;
+        group.name = "group" + std::to_string(id);
+    }
+}
+
+void BulletinBoard::connectClient(int clientID, const std::string& username) {
+    // Add user to the map
+    {
+        std::lock_guard<std::mutex> guard(clientListMutex);
+        clients[clientID] = username;
+        clientSockets.push_back(clientID);
+    }
+
+    // Output list of groups when client connects
+    transport.send(clientID, listGroups());
+}
+
+bool BulletinBoard::handleMessage(int clientID, const std::string& msg) {
+    std::string username;
+    {
+        std::lock_guard<std::mutex> guard(clientListMutex);
+        auto it = clients.find(clientID);
+        if (it != clients.end()) username = it->second;
+    }
+
+    Command command = parseCommand(msg);
+    if (command.name == "%groups") {
+        transport.send(clientID, listGroups());
+    } else if (command.name == "%groupjoin") {
+        joinGroup(clientID, command.args);
+    } else if (command.name == "%groupleave") {
+        leaveGroup(clientID, command.args);
+    } else if (command.name == "%groupusers") {
+        listGroupUsers(clientID, command.args);
+    } else if (command.name == "%grouppost") {
+        postToGroup(clientID, username, command.args);
+    } else if (command.name == "%groupmessage") {
+        sendGroupMessage(clientID, command.args);
+    } else if (command.name == "%groupsearch") {
+        searchGroup(clientID, command.args);
+    } else if (command.name == "%leave") {
+        // Remove the client from the global list and map, then notify other clients that the user has left
+        removeClient(clientID);
+        notifyLeft(username);
+        return false; // Exit the loop and close the client connection
+    } else if (command.name == "%users") {
+        // Send the current user list to the client
+        transport.send(clientID, listUsers());
+    } else if (command.name == "%search") {
+        searchBoard(clientID, command.args);
+    } else if (command.name == "%post") {
+        postToBoard(clientID, username, command.args);
+    } else if (command.name == "%exit") {
+        // Notify other clients that the user has left, then remove the client from the global list and map
+        notifyLeft(username);
+        removeClient(clientID);
+        return false; // Exit the loop and close the client connection
+    } else if (command.name == "%join") {
+        joinBoard(clientID, username);
+    } else if (command.name == "%message") {
+        sendBoardMessage(clientID, command.args);
+    }
+    return true;
+}
+
+void BulletinBoard::disconnectClient(int clientID) {
+    removeClient(clientID);
+    std::lock_guard<std::mutex> guard(groupMutex);
+    for (int groupID : userGroups[clientID]) {
+        groups[groupID].members.erase(clientID);
+    }
+    userGroups.erase(clientID);
+}
+
+std::vector<int> BulletinBoard::connectedClients() {
+    std::lock_guard<std::mutex> guard(clientListMutex);
+    return clientSockets;
+}
+
+// Look up a group by numeric ID, or by name if the identifier is not a number
+Group* BulletinBoard::findGroup(const std::string& groupIdentifier) {
+    try {
+        auto it = groups.find(std::stoi(groupIdentifier));
+        return it != groups.end() ? &it->second : nullptr;
+    } catch (std::logic_error&) {
+        // Not a number so treat it as a name
+        for (auto& group : groups) {
+            if (group.second.name == groupIdentifier) {
+                return &group.second;
+            }
+        }
+        return nullptr;
+    }
+}
+
+bool BulletinBoard::isMember(int clientID, int groupID) {
+    std::lock_guard<std::mutex> guard(groupMutex);
+    auto it = userGroups.find(clientID);
+    return it != userGroups.end() && it->second.find(groupID) != it->second.end();
+}
+
+// Copy of a group's members, safe to use after the lock is released
+std::vector<int> BulletinBoard::groupMembers(const Group& group) {
+    std::lock_guard<std::mutex> guard(groupMutex);
+    return std::vector<int>(group.members.begin(), group.members.end());
+}
+
+std::string BulletinBoard::listGroups() {
+    std::string availableGroups = "Available Groups:\n";
+    for (const auto& group : groups) {
+        availableGroups += "ID: " + std::to_string(group.second.id) + " - " + group.second.name + "\n";
+    }
+    return availableGroups;
+}
+
+// Names of every connected client, one per line
+std::string BulletinBoard::listUsers() {
+    std::lock_guard<std::mutex> guard(clientListMutex);
+    std::string userList;
+    for (const auto& client : clients) {
+        userList += client.second + "\n";
+    }
+    return userList;
+}
+
+// Header followed by the name of each member still connected, one per line
+std::string BulletinBoard::listMembers(const std::string& header, const std::vector<int>& members) {
+    std::lock_guard<std::mutex> guard(clientListMutex);
+    std::string memberList = header;
+    for (int member : members) {
+        auto it = clients.find(member);
+        if (it != clients.end()) {
+            memberList += it->second + "\n";
+        }
+    }
+    return memberList;
+}
+
+void BulletinBoard::broadcastMessage(const std::string& message, int excludeClient) {
+    // Copy the list of client IDs to avoid modifying it while iterating
+    std::vector<int> clientsToSend;
+    {
+        std::lock_guard<std::mutex> guard(clientListMutex);
+        for (int client : clientSockets) {
+            if (client != excludeClient) {
+                clientsToSend.push_back(client);
+            }
+        }
+    }
+
+    // Send messages outside the lock
+    for (int client : clientsToSend) {
+        transport.send(client, message);
+    }
+}
+
+void BulletinBoard::broadcastMessageToGroup(int groupID, const std::string& message, const std::string& messageContent, int excludeClient) {
+    auto it = groups.find(groupID);
+    if (it == groups.end()) {
+        transport.send(excludeClient, "Group ID not found, use %groups to see group IDs \n");
+        return;
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> guard(it->second.historyMutex);
+        it->second.messageIDs.push_back(messageContent);
+        indexMessage(it->second.searchIndex, it->second.messageIDs.size(), messageContent);
+        it->second.messageIDCounter++;
+    }
+
+    for (int member : groupMembers(it->second)) {
+        if (member != excludeClient) {
+            transport.send(member, message);
+        }
+    }
+}
+
+void BulletinBoard::notifyLeft(const std::string& username) {
+    std::vector<int> clientsToSend;
+    {
+        std::lock_guard<std::mutex> guard(clientListMutex);
+        for (const auto& client : clients) {
+            clientsToSend.push_back(client.first);
+        }
+    }
+    for (int client : clientsToSend) {
+        transport.send(client, username + " has left the chat.");
+    }
+}
+
+void BulletinBoard::removeClient(int clientID) {
+    std::lock_guard<std::mutex> guard(clientListMutex);
+    clientSockets.erase(std::remove(clientSockets.begin(), clientSockets.end(), clientID), clientSockets.end());
+    clients.erase(clientID);
+}
+
+void BulletinBoard::joinGroup(int clientID, const std::string& args) {
+    std::string groupIdentifier = args;
+    groupIdentifier.erase(std::remove_if(groupIdentifier.begin(), groupIdentifier.end(), isspace), groupIdentifier.end()); // Remove any extra spaces
+
+    Group* group = findGroup(groupIdentifier);
+    if (group == nullptr) {
+        transport.send(clientID, "Group not found\n");
+        return;
+    }
+
+    std::vector<int> members;
+    {
+        std::lock_guard<std::mutex> guard(groupMutex);
+        group->members.insert(clientID);
+        userGroups[clientID].insert(group->id); // Add group to user's list of groups
+        members.assign(group->members.begin(), group->members.end());
+    }
+    transport.send(clientID, "Joined group " + group->name + "\n");
+
+    // Send current members in the group
+    transport.send(clientID, listMembers("Current members in " + group->name + ":\n", members));
+
+    // Notify all other members about the new member
+    std::string username;
+    {
+        std::lock_guard<std::mutex> guard(clientListMutex);
+        auto it = clients.find(clientID);
+        if (it != clients.end()) username = it->second;
+    }
+    std::string notification = username + " has joined the group " + group->name + "\n";
+    for (int member : members) {
+        if (member != clientID) { // Don't send the notification to the user who just joined
+            transport.send(member, notification);
+        }
+    }
+}
+
+void BulletinBoard::leaveGroup(int clientID, const std::string& args) {
+    std::string groupIdentifier = args;
+    groupIdentifier.erase(std::remove_if(groupIdentifier.begin(), groupIdentifier.end(), isspace), groupIdentifier.end()); // Clean spaces
+
+    Group* group = findGroup(groupIdentifier);
+    bool left = false;
+    if (group != nullptr) {
+        std::lock_guard<std::mutex> guard(groupMutex);
+        left = userGroups[clientID].erase(group->id) > 0; // Remove group from user's list of groups
+        group->members.erase(clientID);
+    }
+
+    if (!left) {
+        transport.send(clientID, "Group not found or not a member\n");
+        return;
+    }
+    transport.send(clientID, "Left group " + group->name + "\n");
+}
+
+void BulletinBoard::listGroupUsers(int clientID, const std::string& args) {
+    std::string groupIdentifier = args;
+    groupIdentifier.erase(std::remove_if(groupIdentifier.begin(), groupIdentifier.end(), isspace), groupIdentifier.end()); // Clean spaces
+
+    Group* group = findGroup(groupIdentifier);
+    if (group == nullptr || !isMember(clientID, group->id)) {
+        transport.send(clientID, "Group not found or access denied\n");
+        return;
+    }
+
+    // User is a member of the group, list users
+    transport.send(clientID, listMembers("Users in " + group->name + ":\n", groupMembers(*group)));
+}
+
+void BulletinBoard::postToGroup(int clientID, const std::string& username, const std::string& args) {
+    // Format is "<group ID> <message>"
+    std::istringstream iss(args);
+    int groupID;
+    if (!(iss >> groupID)) {
+        transport.send(clientID, args + " was not recognized as a group ID number, use format: %grouppost id message");
+        return;
+    }
+    std::string extractedMessage;
+    std::getline(iss >> std::ws, extractedMessage);
+    if (extractedMessage.empty()) {
+        return;
+    }
+
+    if (groups.find(groupID) == groups.end()) {
+        transport.send(clientID, "Group ID not found, use %groups to see group IDs \n");
+    } else if (!isMember(clientID, groupID)) {
+        transport.send(clientID, "Cannot send messages until you have joined the group");
+    } else {
+        std::string message = username + " posted to group " + std::to_string(groupID) + ": \n" + extractedMessage;
+        broadcastMessageToGroup(groupID, message, extractedMessage, clientID);
+    }
+}
+
+void BulletinBoard::sendGroupMessage(int clientID, const std::string& args) {
+    // Format is "<group ID> <message ID>"
+    std::istringstream iss(args);
+    int groupID, messageID;
+    if (!(iss >> groupID >> messageID)) {
+        transport.send(clientID, "Group or Message ID was not recognized");
+        return;
+    }
+    auto it = groups.find(groupID);
+    if (it == groups.end() || !isMember(clientID, groupID)) {
+        transport.send(clientID, "You have not joined this group");
+        return;
+    }
+
+    std::string reply;
+    {
+        std::shared_lock<std::shared_mutex> guard(it->second.historyMutex);
+        if (messageID < 1 || messageID > static_cast<int>(it->second.messageIDs.size())) {
+            reply = "Message ID does not exist";
+        } else {
+            reply = "Message: " + std::to_string(messageID) + " " + it->second.messageIDs[messageID - 1];
+        }
+    }
+    transport.send(clientID, reply);
+}
+
+void BulletinBoard::searchGroup(int clientID, const std::string& args) {
+    std::istringstream iss(args);
+    std::string groupIdentifier, query;
+    iss >> groupIdentifier >> std::ws;
+    std::getline(iss, query);
+
+    Group* group = findGroup(groupIdentifier);
+    if (group == nullptr || !isMember(clientID, group->id)) {
+        transport.send(clientID, "Group not found or not a member\n");
+        return;
+    }
+
+    std::string results;
+    {
+        std::shared_lock<std::shared_mutex> guard(group->historyMutex);
+        results = searchMessages(group->searchIndex, group->messageIDs, query);
+    }
+    transport.send(clientID, results);
+}
+
+void BulletinBoard::joinBoard(int clientID, const std::string& username) {
+    // Notify other clients that the user has joined the group
+    std::vector<int> clientsToNotify;
+    {
+        std::lock_guard<std::mutex> guard(clientListMutex);
+        for (const auto& client : clients) {
+            if (client.first != clientID && std::find(clientSockets.begin(), clientSockets.end(), client.first) != clientSockets.end()) {
+                clientsToNotify.push_back(client.first);
+            }
+        }
+        // Add the client to the list of joined clients
+        clients[clientID] = username;
+    }
+    for (int client : clientsToNotify) {
+        transport.send(client, username + " has joined the group.");
+    }
+
+    std::string header = "Group Members:\n";
+    // Send the user list to the client, with the header before it
+    transport.send(clientID, header + listUsers());
+}
+
+void BulletinBoard::postToBoard(int clientID, const std::string& username, const std::string& args) {
+    if (args.empty()) {
+        return;
+    }
+    // Store, index and number the post together so the announced ID is the one it is stored under
+    std::string postMsg;
+    {
+        std::unique_lock<std::shared_mutex> guard(historyMutex);
+        messageIDs.push_back(args);
+        indexMessage(boardIndex, messageIDs.size(), args);
+        postMsg = "Message ID: " + std::to_string(messageIDs.size()) + "\n" + username + " posted: " + args + "\n";
+    }
+    broadcastMessage(postMsg, clientID);
+}
+
+void BulletinBoard::sendBoardMessage(int clientID, const std::string& args) {
+    std::istringstream iss(args);
+    int messageIDNum = 0;
+    iss >> messageIDNum;
+
+    std::string reply;
+    {
+        std::shared_lock<std::shared_mutex> guard(historyMutex);
+        if (messageIDs.empty()) { //Send Message to client and return nothing if message history is empty
+            reply = "There are no previous messages in this bulletin board";
+        } else if (messageIDNum < 1 || messageIDNum > static_cast<int>(messageIDs.size())) {
+            reply = "The ID Number entered does not exist";
+        } else {
+            reply = "Message" + std::to_string(messageIDNum) + ": " + messageIDs[messageIDNum - 1];
+        }
+    }
+    transport.send(clientID, reply);
+}
+
+void BulletinBoard::searchBoard(int clientID, const std::string& args) {
+    std::string results;
+    {
+        std::shared_lock<std::shared_mutex> guard(historyMutex);
+        results = searchMessages(boardIndex, messageIDs, args);
+    }
+    transport.send(clientID, results);
+}
@@ -0,0 +1,93 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "search_index.h"
+
+// Where the board sends its output. The server implements this over sockets,
+// the benchmarks use an in-memory transport so no network is needed.
+class Transport {
+public:
+    virtual ~Transport() = default;
+    virtual void send(int clientID, const std::string& message) = 0;
+};
+
+struct Group {
+    int id; // Numeric ID for the group
+    std::set<int> members; // Store client IDs that are members of the group
+    std::vector<std::string> messages; // Messages posted to the group
+    std::string name; // Name of the group
+    std::vector<std::string> messageIDs; //Message history of each group
+    int messageIDCounter = 1;
+    SearchIndex searchIndex; // Index over this group's messageIDs
+    std::shared_mutex historyMutex; // Guards messageIDs, messageIDCounter and searchIndex; searches and lookups share it
+};
+
+// A client message split into the command word and everything after it
+struct Command {
+    std::string name; // e.g. "%grouppost"
+    std::string args; // Rest of the message after the first space, empty if there is none
+};
+
+Command parseCommand(const std::string& msg);
+
+// Board, group and session state for every connected client.
+// Clients are identified by an integer ID (the server uses the socket descriptor),
+// and all output goes through the Transport so the logic can run without sockets.
+class BulletinBoard {
+public:
+    explicit BulletinBoard(Transport& transport);
+
+    // Register a client and send it the list of available groups
+    void connectClient(int clientID, const std::string& username);
+    // Handle one message from a client. Returns false once the client asked to disconnect.
+    bool handleMessage(int clientID, const std::string& msg);
+    // Drop a client from the board and all groups (safe to call after %leave or %exit)
+    void disconnectClient(int clientID);
+    std::vector<int> connectedClients();
+
+private:
+    Group* findGroup(const std::string& groupIdentifier);
+    bool isMember(int clientID, int groupID);
+    std::vector<int> groupMembers(const Group& group);
+    std::string listGroups();
+    std::string listUsers();
+    std::string listMembers(const std::string& header, const std::vector<int>& members);
+    void broadcastMessage(const std::string& message, int excludeClient);
+    void broadcastMessageToGroup(int groupID, const std::string& message, const std::string& messageContent, int excludeClient);
+    void notifyLeft(const std::string& username);
+    void removeClient(int clientID);
+
+    void joinGroup(int clientID, const std::string& args);
+    void leaveGroup(int clientID, const std::string& args);
+    void listGroupUsers(int clientID, const std::string& args);
+    void postToGroup(int clientID, const std::string& username, const std::string& args);
+    void sendGroupMessage(int clientID, const std::string& args);
+    void searchGroup(int clientID, const std::string& args);
+    void joinBoard(int clientID, const std::string& username);
+    void postToBoard(int clientID, const std::string& username, const std::string& args);
+    void sendBoardMessage(int clientID, const std::string& args);
+    void searchBoard(int clientID, const std::string& args);
+
+    // Each mutex guards its own state and none is held while another is taken or while
+    // sending, so a client that is slow to read never holds up the rest of the board.
+    // The groups map itself (IDs and names) never changes after construction.
+    Transport& transport;
+    std::vector<int> clientSockets; // Store connected client IDs
+    std::map<int, std::string> clients; // Map client ID to client name
+    std::mutex clientListMutex; // Mutex for thread-safe access to the clientSockets and clients
+    std::map<int, Group> groups; // Map group ID to Group structure
+    std::map<int, std::set<int>> userGroups; // Maps client IDs to a set of group IDs they are part of
+    std::mutex groupMutex; // Mutex for thread-safe access to each group's members and userGroups
+    std::vector<std::string> messageIDs; // Message history of the main board, message ID n is messageIDs[n - 1]
+    SearchIndex boardIndex; // Index over messageIDs (the main board)
+    std::shared_mutex historyMutex; // Guards messageIDs and boardIndex; searches and lookups share it, posts take it exclusively
+};
+
+#endif
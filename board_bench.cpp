@@ -0,0 +1,129 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "board.h"
+
+// Micro-benchmarks for the board logic, run in-process with no sockets.
+// Usage: ./board_bench [iterations multiplier]
+
+// Discards output but keeps a running byte count so the sends cannot be optimized away
+class CountingTransport : public Transport {
+public:
+    void send(int, const std::string& message) override {
+        bytesSent += message.size();
+        messagesSent++;
+    }
+    size_t bytesSent = 0;
+    size_t messagesSent = 0;
+};
+
+size_t checksum = 0; // Accumulates results from every benchmark
+
+// Run body(i) for the given number of iterations and print the time per operation
+template <typename Body>
+void runBenchmark(const char* name, int iterations, Body body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        body(i);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double nanoseconds = std::chrono::duration<double, std::nano>(elapsed).count();
+    std::printf("%-32s %10d iterations %12.1f ns/op\n", name, iterations, nanoseconds / iterations);
+}
+
+// Board with the given number of connected clients, IDs 1..clientCount
+void connectClients(BulletinBoard& board, int clientCount) {
+    for (int id = 1; id <= clientCount; id++) {
+        board.connectClient(id, "user" + std::to_string(id));
+    }
+}
+
+const char* samplePosts[] = {
+    "meeting notes for the networks project are up",
+    "does anyone know how the server handles group membership",
+    "the quick brown fox jumps over the lazy dog",
+    "reminder: demo is on friday, bring your laptop",
+    "posting the final report draft for review tonight",
+};
+
+int main(int argc, char* argv[]) {
+    int scale = argc > 1 ? std::atoi(argv[1]) : 1;
+    if (scale < 1) scale = 1;
+
+    // Command parsing
+    {
+        const std::vector<std::string> commands = {
+            "%groups", "%groupjoin 3", "%grouppost 2 hello everyone in the group",
+            "%groupmessage 1 4", "%search \"networks project\"", "%post status update",
+        };
+        runBenchmark("parseCommand", 1000000 * scale, [&](int i) {
+            Command command = parseCommand(commands[i % commands.size()]);
+            checksum += command.name.size() + command.args.size();
+        });
+    }
+
+    // Membership updates: join and leave a group with 100 other members in it
+    {
+        CountingTransport transport;
+        BulletinBoard board(transport);
+        connectClients(board, 101);
+        for (int id = 2; id <= 101; id++) {
+            board.handleMessage(id, "%groupjoin 1");
+        }
+        runBenchmark("groupjoin + groupleave", 20000 * scale, [&](int) {
+            board.handleMessage(1, "%groupjoin 1");
+            board.handleMessage(1, "%groupleave 1");
+        });
+        checksum += transport.bytesSent;
+    }
+
+    // Fan-out encoding: one group post delivered to every other member
+    for (int members : {10, 100, 1000}) {
+        CountingTransport transport;
+        BulletinBoard board(transport);
+        connectClients(board, members);
+        for (int id = 1; id <= members; id++) {
+            board.handleMessage(id, "%groupjoin 2");
+        }
+        std::string name = "grouppost fan-out to " + std::to_string(members);
+        runBenchmark(name.c_str(), 200000 * scale / members, [&](int i) {
+            board.handleMessage(1, std::string("%grouppost 2 ") + samplePosts[i % 5]);
+        });
+        checksum += transport.bytesSent;
+    }
+
+    // History lookups against boards holding a few thousand posts
+    {
+        CountingTransport transport;
+        BulletinBoard board(transport);
+        connectClients(board, 2);
+        board.handleMessage(1, "%groupjoin 3");
+        for (int i = 0; i < 5000; i++) {
+            board.handleMessage(1, std::string("%post ") + samplePosts[i % 5] + " " + std::to_string(i));
+            board.handleMessage(1, std::string("%grouppost 3 ") + samplePosts[i % 5] + " " + std::to_string(i));
+        }
+
+        runBenchmark("message lookup", 200000 * scale, [&](int i) {
+            board.handleMessage(2, "%message " + std::to_string(i % 5000 + 1));
+        });
+        runBenchmark("groupmessage lookup", 200000 * scale, [&](int i) {
+            board.handleMessage(1, "%groupmessage 3 " + std::to_string(i % 5000 + 1));
+        });
+        runBenchmark("search single term", 200 * scale, [&](int) {
+            board.handleMessage(2, "%search laptop");
+        });
+        runBenchmark("search phrase", 200 * scale, [&](int) {
+            board.handleMessage(2, "%search \"group membership\"");
+        });
+        runBenchmark("groupsearch no match", 20000 * scale, [&](int) {
+            board.handleMessage(1, "%groupsearch 3 nonexistent");
+        });
+        checksum += transport.bytesSent;
+    }
+
+    std::printf("checksum %zu\n", checksum);
+    return 0;
+}
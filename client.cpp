@@ -1,15 +1,73 @@
 #include <iostream>
 #include <string>
-#include <thread>
-#include <mutex>
 #include <cstring>
+#include <cerrno>
+#include <poll.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <sstream>
+#include <vector>
+#include <algorithm>
 
-void handleServerResponses(int serverSocket);
+#include "protocol.h"
+
+// The client runs a single poll() loop over stdin and the server socket, so a busy
+// server never waits on the user typing and the user never waits on the server.
+
+// Bytes read from a descriptor that have not been consumed yet, kept in data[start, end).
+// Reads go straight into the spare space after end, which is only grown (never refilled)
+// when too little is left, so a read costs nothing beyond the bytes that actually arrive.
+struct ReceiveBuffer {
+    std::vector<char> data = std::vector<char>(65536);
+    size_t start = 0; // Offset of the first unconsumed byte
+    size_t end = 0; // Offset just past the last received byte
+
+    // Take the next complete piece of data ending with delimiter (delimiter removed), if there is one
+    bool next(char delimiter, std::string& piece) {
+        const char* first = data.data() + start;
+        const char* found = static_cast<const char*>(memchr(first, delimiter, end - start));
+        if (found == nullptr) {
+            return false;
+        }
+        piece.assign(first, found - first);
+        start += (found - first) + 1;
+        if (start == end) {
+            start = end = 0;
+        }
+        return true;
+    }
+
+    // Make sure at least minFree bytes are free after end, moving unconsumed bytes to the front first
+    void reserve(size_t minFree) {
+        if (data.size() - end >= minFree) return;
+        memmove(data.data(), data.data() + start, end - start);
+        end -= start;
+        start = 0;
+        if (data.size() - end < minFree) {
+            data.resize(std::max(data.size() * 2, end + minFree));
+        }
+    }
+
+    // Whatever is left that never got a delimiter, consuming it
+    std::string rest() {
+        std::string remaining(data.data() + start, end - start);
+        start = end = 0;
+        return remaining;
+    }
+};
+
+enum class ClientState {
+    Disconnected, // Waiting for %connect
+    EnteringUsername, // Connected, next line is the username
+    Connected // Username sent, lines are commands
+};
+
+ssize_t readInto(int fd, ReceiveBuffer& buffer);
+void handleInputLine(const std::string& inputLine, ClientState& state, int sock, struct sockaddr_in& serv_addr, bool& running);
+void formatServerMessage(const std::string& msg, std::string& output);
+bool sendLine(int serverSocket, const std::string& line);
 void sendCommand(int serverSocket, const std::string& command, const std::string& args = "");
 
 int main() {
@@ -34,129 +92,190 @@ int main() {
 
     std::cout << "Client started. Use %connect [ip] [port] to connect to a server." << std::endl;
 
-    // Client command loop
-    bool joined = false; // Track if the client has joined the message board
-    std::string inputLine;
-    std::string username; // Username of the client
-    while (true) {
-        std::getline(std::cin, inputLine); // Read user input from console
-        if (inputLine.empty()) continue;
+    ClientState state = ClientState::Disconnected;
+    ReceiveBuffer inputBuffer; // Lines typed by the user
+    ReceiveBuffer serverBuffer; // Frames sent by the server
+    bool inputOpen = true; // False once stdin reaches end of file
+    bool running = true;
+    while (running) {
+        struct pollfd fds[2];
+        fds[0] = {inputOpen ? STDIN_FILENO : -1, POLLIN, 0}; // poll() skips negative descriptors
+        fds[1] = {sock, POLLIN, 0};
+        int fdCount = state == ClientState::Disconnected ? 1 : 2; // Only watch the socket once it is connected
+
+        if (poll(fds, fdCount, -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "poll failed: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        // Read what the server has sent so far and print all complete frames in one write
+        if (fdCount == 2 && fds[1].revents != 0) {
+            ssize_t bytesReceived = readInto(sock, serverBuffer);
+            std::string output;
+            std::string msg;
+            while (serverBuffer.next(frameEnd, msg)) {
+                formatServerMessage(msg, output);
+            }
+            if (!output.empty()) {
+                std::cout << output << std::flush;
+            }
+            if (bytesReceived <= 0) {
+                // Either an error occurred or the server closed the connection
+                if (inputOpen) {
+                    std::cerr << "Server disconnected or error receiving message." << std::endl;
+                }
+                break;
+            }
+        }
 
+        if (inputOpen && fds[0].revents != 0) {
+            ssize_t bytesRead = readInto(STDIN_FILENO, inputBuffer);
+            std::string inputLine;
+            while (running && inputBuffer.next('\n', inputLine)) {
+                handleInputLine(inputLine, state, sock, serv_addr, running);
+            }
+            if (bytesRead <= 0) {
+                // End of input: run a final line that had no newline, then stop sending. The server
+                // still answers everything already sent and closes the connection, which ends the loop.
+                inputOpen = false;
+                std::string lastLine = inputBuffer.rest();
+                if (running && !lastLine.empty()) {
+                    handleInputLine(lastLine, state, sock, serv_addr, running);
+                }
+                if (state == ClientState::Disconnected) {
+                    break;
+                }
+                shutdown(sock, SHUT_WR);
+            }
+        }
+    }
+
+    close(sock); // Close the socket before exiting
+    std::cout << "Disconnected from the server." << std::endl;
+
+    return 0;
+}
+
+// Append whatever is available on fd to the buffer with a single read.
+// Returns the read() result, so 0 means end of file.
+ssize_t readInto(int fd, ReceiveBuffer& buffer) {
+    buffer.reserve(4096);
+    ssize_t bytesRead;
+    do {
+        bytesRead = read(fd, buffer.data.data() + buffer.end, buffer.data.size() - buffer.end);
+    } while (bytesRead < 0 && errno == EINTR);
+    if (bytesRead > 0) {
+        buffer.end += bytesRead;
+    }
+    return bytesRead;
+}
+
+void handleInputLine(const std::string& inputLine, ClientState& state, int sock, struct sockaddr_in& serv_addr, bool& running) {
+    if (state == ClientState::EnteringUsername) {
+        if (!sendLine(sock, inputLine)) { // The server reads the username up to commandEnd
+            std::cerr << "Failed to send username to server." << std::endl;
+        }
+        state = ClientState::Connected;
+        return;
+    }
+    if (inputLine.empty()) return;
+
+    if (state == ClientState::Disconnected) {
         if (inputLine.find("%connect") == 0) {
             std::istringstream iss(inputLine);
-            std::string cmd, newIP;
-            int newPort;
-            iss >> cmd >> newIP >> newPort;
-            if (!newIP.empty() && newPort > 0) {
-                serverIP = newIP;
-                PORT = newPort;
+            std::string cmd, serverIP;
+            int PORT = 0;
+            iss >> cmd >> serverIP >> PORT;
+            if (!serverIP.empty() && PORT > 0) {
                 serv_addr.sin_port = htons(PORT);
 
                 // Convert IPv4 and IPv6 addresses from text to binary form
                 if (inet_pton(AF_INET, serverIP.c_str(), &serv_addr.sin_addr) <= 0) {
                     std::cout << "\nInvalid address/Address not supported\n";
-                    continue;
+                    return;
                 }
 
                 if (connect(sock, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
                     std::cout << "\nConnection Failed\n";
-                    continue;
+                    return;
                 }
 
                 std::cout << "Connected to the server at " << serverIP << ":" << PORT << std::endl;
 
-                // Prompt for username and send it to the server
-                std::cout << "Enter username: ";
-                std::getline(std::cin, username);
-                username += "\n"; // Ensure to append a newline character to signal end of input
-                send(sock, username.c_str(), username.length(), 0); // Directly send the username
-
-                break; // Exit the loop and continue with the rest of the client code
+                // Prompt for username, the next line is sent to the server
+                std::cout << "Enter username: " << std::flush;
+                state = ClientState::EnteringUsername;
             } else {
                 std::cout << "Invalid arguments for %connect command\n";
             }
         } else {
             std::cout << "You must connect to the server with %connect [ip] [port] before using other commands.\n";
         }
+        return;
     }
 
-    // Start a thread to handle server responses
-    std::thread serverThread(handleServerResponses, sock);
-    serverThread.detach(); // Don't need to join the thread, letting it run freely
-
-    // Client command loop
-    while (true) {
-        std::getline(std::cin, inputLine); // Read user input from console
-        if (inputLine.empty()) continue;
-        std::cout << "Processing command: " << inputLine << std::endl;
-        if (inputLine.find("%groupjoin ") == 0) {
-            sendCommand(sock, inputLine);
-            // joined = true; // Update the joined status
-        } else if (inputLine == "%groups") {
-            sendCommand(sock, inputLine);
-        // } else if (!joined) {
-            // std::cout << "You must join a message board with %groupjoin before using other commands.\n";
-        } else if (inputLine.find("%groupleave ") == 0) {
-            sendCommand(sock, inputLine);
-            // joined = false; // Update the joined status
-        } else if (inputLine.find("%groupusers ") == 0) {
-            sendCommand(sock, inputLine);
-        } else if (inputLine.find("%grouppost ") == 0) {
-            sendCommand(sock, inputLine);
-        } else if (inputLine.find("%groupmessage ") == 0) {
-            sendCommand(sock, inputLine);
-        } else if (inputLine == "%exit") {
-            break; // Exit the loop and close the application
-        } else if (inputLine.find("%post") == 0 || inputLine.find("%message") == 0 || inputLine == "%users") {
-            // Handle post, message, and users commands
-            sendCommand(sock, inputLine);
-        } else {
-            // Send the message to the server
-            sendCommand(sock, "%message", inputLine);
-        }
+    std::cout << "Processing command: " << inputLine << std::endl;
+    if (inputLine.find("%groupjoin ") == 0) {
+        sendCommand(sock, inputLine);
+    } else if (inputLine == "%groups") {
+        sendCommand(sock, inputLine);
+    } else if (inputLine.find("%groupleave ") == 0) {
+        sendCommand(sock, inputLine);
+    } else if (inputLine.find("%groupusers ") == 0) {
+        sendCommand(sock, inputLine);
+    } else if (inputLine.find("%grouppost ") == 0) {
+        sendCommand(sock, inputLine);
+    } else if (inputLine.find("%groupmessage ") == 0) {
+        sendCommand(sock, inputLine);
+    } else if (inputLine.find("%groupsearch ") == 0) {
+        sendCommand(sock, inputLine);
+    } else if (inputLine == "%exit") {
+        running = false; // Exit the loop and close the application
+    } else if (inputLine.find("%post") == 0 || inputLine.find("%message") == 0 || inputLine.find("%search ") == 0 || inputLine == "%users") {
+        // Handle post, message, search, and users commands
+        sendCommand(sock, inputLine);
+    } else {
+        // Send the message to the server
+        sendCommand(sock, "%message", inputLine);
     }
+}
 
-    close(sock); // Close the socket before exiting
-    std::cout << "Disconnected from the server." << std::endl;
-
-    return 0;
+// Append one message from the server to the output, formatted for display
+void formatServerMessage(const std::string& msg, std::string& output) {
+    output += "\nReceived message from server: \n";
+    if (msg.find("%message") == 0) {
+        // Extract the message content
+        output += "Message: " + msg.substr(9) + "\n"; // Skip "%message "
+    } else if (msg.find("%history") == 0) {
+        // Handle message history
+        size_t newlineIndex = msg.find('\n');
+        output += "Message history:\n" + msg.substr(newlineIndex + 1) + "\n";
+    } else if (msg.find("Joined group ") == 0) {
+        // Extract the group name from the message
+        std::string groupName = msg.substr(13, msg.find("\n") - 13);
+        output += "Successfully joined group: " + groupName + "\n";
+    } else {
+        // Groups list or regular chat message
+        output += msg + "\n";
+    }
 }
 
-void handleServerResponses(int serverSocket) {
-    char buffer[1024];
-    while (true) {
-        memset(buffer, 0, sizeof(buffer));
-        ssize_t bytesReceived = read(serverSocket, buffer, sizeof(buffer) - 1);
-        if (bytesReceived <= 0) {
-            // Either an error occurred or the server closed the connection
-            std::cerr << "Server disconnected or error receiving message." << std::endl;
-            break;
-        }
-        
-        // Display the message from the server
-        std::string msg(buffer, bytesReceived);
-        std::cout << "\n" << "Received message from server: " << std::endl;
-        if (msg.find("Available Groups:") == 0) {
-            // Directly display the groups list
-            std::cout << msg << std::endl;
-        } else if (msg.find("%message") == 0) {
-            // Extract the message content
-            std::string messageContent = msg.substr(9); // Skip "%message "
-            std::cout << "Message: " << messageContent << std::endl;
-        } else if (msg.find("%history") == 0) {
-            // Handle message history
-            size_t newlineIndex = msg.find('\n');
-            std::string history = msg.substr(newlineIndex + 1);
-            std::cout << "Message history:\n" << history << std::endl;
-        } else if (msg.find("Joined group ") == 0) {
-            // Extract the group name from the message
-            std::string groupName = msg.substr(13, msg.find("\n") - 13);
-            std::cout << "Successfully joined group: " << groupName << std::endl;
-        } else {
-            // Regular chat message
-            std::cout << msg << std::endl;
+// Send one line to the server followed by commandEnd, retrying until all of it is written.
+// Returns false if the connection failed.
+bool sendLine(int serverSocket, const std::string& line) {
+    std::string framed = line + commandEnd; // The server splits commands on commandEnd
+    size_t totalSent = 0;
+    while (totalSent < framed.length()) {
+        // MSG_NOSIGNAL so a server that already closed the connection can't kill the client with SIGPIPE
+        ssize_t bytesSent = send(serverSocket, framed.c_str() + totalSent, framed.length() - totalSent, MSG_NOSIGNAL);
+        if (bytesSent < 0) {
+            if (errno == EINTR) continue;
+            return false;
         }
+        totalSent += bytesSent;
     }
+    return true;
 }
 
 void sendCommand(int serverSocket, const std::string& command, const std::string& args) {
@@ -165,8 +284,7 @@ void sendCommand(int serverSocket, const std::string& command, const std::string
         fullCommand += " " + args; // Append arguments to the command if any
     }
 
-    ssize_t bytesSent = write(serverSocket, fullCommand.c_str(), fullCommand.length());
-    if (bytesSent < 0) {
+    if (!sendLine(serverSocket, fullCommand)) {
         std::cerr << "Failed to send command to server." << std::endl;
     } else {
         std::cout << "Command sent: " << fullCommand << std::endl;
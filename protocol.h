@@ -0,0 +1,12 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+// Every message the server sends ends with this byte, so the client can split
+// the TCP stream back into the original messages however the reads arrive.
+const char frameEnd = '\0';
+
+// Every command the client sends (including the username) ends with this byte.
+// The server strips frameEnd from commands so relayed text can't end a frame early.
+const char commandEnd = '\n';
+
+#endif
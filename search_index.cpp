@@ -0,0 +1,230 @@
+#include "search_index.h"
+
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <utility>
+
+const size_t maxSearchResults = 20; // Only the newest matches are returned
+
+// Start offset and length of each alphanumeric run in text, in order of appearance
+static std::vector<std::pair<size_t, size_t>> tokenSpans(const std::string& text) {
+    std::vector<std::pair<size_t, size_t>> spans;
+    size_t start = 0;
+    bool inToken = false;
+    for (size_t i = 0; i <= text.size(); i++) {
+        bool alnum = i < text.size() && isalnum(static_cast<unsigned char>(text[i]));
+        if (alnum && !inToken) {
+            start = i;
+            inToken = true;
+        } else if (!alnum && inToken) {
+            spans.push_back({start, i - start});
+            inToken = false;
+        }
+    }
+    return spans;
+}
+
+std::vector<std::string> tokenize(const std::string& text) {
+    std::vector<std::string> terms;
+    for (const auto& span : tokenSpans(text)) {
+        std::string term = text.substr(span.first, span.second);
+        std::transform(term.begin(), term.end(), term.begin(), [](unsigned char c) { return tolower(c); });
+        terms.push_back(term);
+    }
+    return terms;
+}
+
+// Append a non-negative number to a posting list, 7 bits per byte (high bit set means more bytes follow)
+static void appendVarint(std::string& out, unsigned int value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+static unsigned int readVarint(const std::string& in, size_t& pos) {
+    unsigned int value = 0;
+    int shift = 0;
+    while (pos < in.size()) {
+        unsigned char byte = static_cast<unsigned char>(in[pos++]);
+        value |= static_cast<unsigned int>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+        shift += 7;
+    }
+    return value;
+}
+
+// Walks one encoded posting list an entry at a time, without decoding the rest of it
+struct PostingCursor {
+    const std::string* list;
+    size_t pos = 0; // Byte offset of the next entry
+    int messageID = 0; // Message ID of the current entry
+    std::vector<int> positions; // Term positions in the current entry
+
+    explicit PostingCursor(const std::string* list) : list(list) {}
+
+    // Move to the next entry. Returns false once the list is exhausted.
+    bool next() {
+        if (pos >= list->size()) return false;
+        messageID += readVarint(*list, pos);
+        unsigned int count = readVarint(*list, pos);
+        positions.clear();
+        int position = 0;
+        for (unsigned int i = 0; i < count; i++) {
+            position += readVarint(*list, pos);
+            positions.push_back(position);
+        }
+        return true;
+    }
+};
+
+// Position where the phrase starts in the message all its cursors are on, or -1 if it doesn't occur
+static int phraseStart(const std::vector<PostingCursor>& phrase) {
+    // The phrase matches if every following term sits at the next position
+    for (int start : phrase[0].positions) {
+        bool found = true;
+        for (size_t t = 1; t < phrase.size() && found; t++) {
+            found = std::binary_search(phrase[t].positions.begin(), phrase[t].positions.end(), start + static_cast<int>(t));
+        }
+        if (found) return start;
+    }
+    return -1;
+}
+
+// Short excerpt of a message around the terms at positions [first, first + count)
+static std::string makeSnippet(const std::string& content, int first, size_t count) {
+    const size_t context = 30; // Characters to show on each side of the match
+    std::vector<std::pair<size_t, size_t>> spans = tokenSpans(content);
+    size_t matchStart = 0, matchEnd = 0;
+    if (first >= 0 && first + count <= spans.size()) {
+        matchStart = spans[first].first;
+        matchEnd = spans[first + count - 1].first + spans[first + count - 1].second;
+    }
+
+    size_t start = matchStart > context ? matchStart - context : 0;
+    size_t end = std::min(content.size(), matchEnd + context);
+    std::string snippet = content.substr(start, end - start);
+    std::replace(snippet.begin(), snippet.end(), '\n', ' ');
+    if (start > 0) snippet = "..." + snippet;
+    if (end < content.size()) snippet += "...";
+    return snippet;
+}
+
+void indexMessage(SearchIndex& index, int messageID, const std::string& content) {
+    std::vector<std::string> terms = tokenize(content);
+    std::map<std::string, std::vector<int>> termPositions;
+    for (size_t i = 0; i < terms.size(); i++) {
+        termPositions[terms[i]].push_back(i);
+    }
+
+    for (const auto& entry : termPositions) {
+        PostingList& list = index.postings[entry.first];
+        appendVarint(list.encoded, messageID - list.lastMessageID);
+        appendVarint(list.encoded, entry.second.size());
+        int previous = 0;
+        for (int position : entry.second) {
+            appendVarint(list.encoded, position - previous);
+            previous = position;
+        }
+        list.lastMessageID = messageID;
+    }
+}
+
+std::string searchMessages(const SearchIndex& index, const std::vector<std::string>& history, const std::string& query) {
+    // Split the query into phrases; an unquoted word is a phrase of one term
+    std::vector<std::vector<std::string>> phrases;
+    bool quoted = false;
+    std::string segment;
+    for (size_t i = 0; i <= query.size(); i++) {
+        if (i == query.size() || query[i] == '"') {
+            std::vector<std::string> terms = tokenize(segment);
+            if (quoted) {
+                if (!terms.empty()) phrases.push_back(terms);
+            } else {
+                for (const std::string& term : terms) {
+                    phrases.push_back({term});
+                }
+            }
+            segment.clear();
+            quoted = !quoted;
+        } else {
+            segment += query[i];
+        }
+    }
+    if (phrases.empty()) {
+        return "Search query is empty, use format: %search words or \"exact phrase\"\n";
+    }
+
+    // One cursor per query term, each already on its first entry; a missing term means nothing can match
+    std::vector<std::vector<PostingCursor>> cursors(phrases.size());
+    bool exhausted = false;
+    for (size_t p = 0; p < phrases.size() && !exhausted; p++) {
+        for (const std::string& term : phrases[p]) {
+            auto it = index.postings.find(term);
+            if (it == index.postings.end()) {
+                exhausted = true;
+                break;
+            }
+            cursors[p].emplace_back(&it->second.encoded);
+            cursors[p].back().next();
+        }
+    }
+
+    // Intersect the lists in message ID order, keeping only the newest matches
+    std::deque<std::pair<int, int>> newest; // Message ID and where the first phrase starts in it
+    size_t matchCount = 0;
+    while (!exhausted) {
+        int target = 0;
+        for (const auto& phrase : cursors) {
+            for (const PostingCursor& cursor : phrase) {
+                target = std::max(target, cursor.messageID);
+            }
+        }
+
+        // Bring every cursor up to the highest message ID any of them is on
+        bool aligned = true;
+        for (auto& phrase : cursors) {
+            for (PostingCursor& cursor : phrase) {
+                while (!exhausted && cursor.messageID < target) {
+                    exhausted = !cursor.next();
+                }
+                aligned = aligned && cursor.messageID == target;
+            }
+        }
+        if (exhausted) break;
+        if (!aligned) continue;
+
+        int firstStart = phraseStart(cursors[0]);
+        bool matched = firstStart >= 0;
+        for (size_t p = 1; p < cursors.size() && matched; p++) {
+            matched = phraseStart(cursors[p]) >= 0;
+        }
+        if (matched) {
+            matchCount++;
+            newest.push_back({target, firstStart});
+            if (newest.size() > maxSearchResults) newest.pop_front();
+        }
+
+        for (auto& phrase : cursors) {
+            for (PostingCursor& cursor : phrase) {
+                exhausted = exhausted || !cursor.next();
+            }
+        }
+    }
+
+    if (matchCount == 0) {
+        return "No messages matched: " + query + "\n";
+    }
+    std::string results = "Search results for: " + query + "\n";
+    if (matchCount > newest.size()) {
+        results += "Showing the newest " + std::to_string(newest.size()) + " of " + std::to_string(matchCount) +
+                   " matches, add more words to narrow the search\n";
+    }
+    for (const auto& match : newest) {
+        results += "Message ID: " + std::to_string(match.first) + " - " +
+                   makeSnippet(history[match.first - 1], match.second, phrases[0].size()) + "\n";
+    }
+    return results;
+}
@@ -0,0 +1,32 @@
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Inverted index over posted messages, used by %search and %groupsearch
+// Each term maps to a posting list of (message ID, positions) entries. Message IDs only
+// ever grow, so entries are stored as deltas packed into varints to keep the lists small.
+struct PostingList {
+    std::string encoded; // Varint encoded (message ID delta, position count, position deltas...) entries
+    int lastMessageID = 0; // Last message ID in the list, the base for the next delta
+};
+
+struct SearchIndex {
+    std::map<std::string, PostingList> postings; // Term -> posting list
+};
+
+// Split text into lowercase alphanumeric terms, in order of appearance
+std::vector<std::string> tokenize(const std::string& text);
+
+// Add a newly posted message to an index. Messages must be indexed in increasing ID order.
+void indexMessage(SearchIndex& index, int messageID, const std::string& content);
+
+// Run a query against an index and format the matches for the client.
+// Bare words must all appear in a message; words in double quotes must appear as an exact phrase.
+// history holds the indexed messages, where message ID n is history[n - 1].
+// Only the newest matches are listed, with a note when there are more.
+std::string searchMessages(const SearchIndex& index, const std::vector<std::string>& history, const std::string& query);
+
+#endif
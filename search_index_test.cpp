@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "search_index.h"
+
+// Checks for the search index, run in-process by ctest.
+// Exits non-zero if any check fails.
+
+int failures = 0;
+
+void check(bool condition, const std::string& name) {
+    if (!condition) {
+        std::printf("FAIL: %s\n", name.c_str());
+        failures++;
+    }
+}
+
+bool contains(const std::string& text, const std::string& part) {
+    return text.find(part) != std::string::npos;
+}
+
+// Index of posts where message ID n is history[n - 1]
+struct TestBoard {
+    SearchIndex index;
+    std::vector<std::string> history;
+
+    void post(const std::string& content) {
+        history.push_back(content);
+        indexMessage(index, history.size(), content);
+    }
+    std::string search(const std::string& query) {
+        return searchMessages(index, history, query);
+    }
+};
+
+void testBareWordsAreAnded() {
+    TestBoard board;
+    board.post("the brown fox");
+    board.post("a lazy dog");
+    board.post("the brown dog sleeps");
+    std::string results = board.search("brown dog");
+    check(contains(results, "Message ID: 3 "), "bare words: post with both words matches");
+    check(!contains(results, "Message ID: 1 "), "bare words: post with only the first word is skipped");
+    check(!contains(results, "Message ID: 2 "), "bare words: post with only the second word is skipped");
+    check(contains(board.search("Brown FOX"), "Message ID: 1 "), "bare words: matching ignores case");
+    check(contains(board.search("brown cat"), "No messages matched"), "bare words: unknown word matches nothing");
+}
+
+void testPhrases() {
+    TestBoard board;
+    board.post("a brown dog ran");
+    board.post("the dog was brown");
+    std::string hit = board.search("\"brown dog\"");
+    check(contains(hit, "Message ID: 1 "), "phrase: words in order match");
+    check(!contains(hit, "Message ID: 2 "), "phrase: words present but apart do not match");
+    check(contains(board.search("\"dog brown\""), "No messages matched"), "phrase: reversed phrase does not match");
+    check(contains(board.search("\"dog was\" ran"), "No messages matched"), "phrase: phrase and bare word must be in the same post");
+}
+
+void testRepeatedTerms() {
+    TestBoard board;
+    board.post("dog eat dog world");
+    board.post("dog dog dog");
+    std::string results = board.search("\"dog dog\"");
+    check(contains(results, "Message ID: 2 "), "repeated terms: repeated word phrase matches");
+    check(!contains(results, "Message ID: 1 "), "repeated terms: repeated word not adjacent does not match");
+    check(contains(board.search("dog dog"), "Message ID: 1 "), "repeated terms: repeated bare word matches once present");
+    check(contains(board.search("\"eat dog world\""), "Message ID: 1 "), "repeated terms: phrase after an earlier occurrence matches");
+}
+
+void testUnterminatedQuote() {
+    TestBoard board;
+    board.post("brown dog");
+    board.post("dog brown");
+    std::string results = board.search("\"brown dog");
+    check(contains(results, "Message ID: 1 "), "unterminated quote: rest of the query is a phrase");
+    check(!contains(results, "Message ID: 2 "), "unterminated quote: reversed words do not match");
+    check(contains(board.search("\""), "Search query is empty"), "unterminated quote: lone quote is an empty query");
+}
+
+void testMultiByteVarints() {
+    TestBoard board;
+    for (int i = 1; i <= 300; i++) {
+        board.post(i == 200 ? "the needle post" : "filler post " + std::to_string(i));
+    }
+    // A term far into a long post, so its position also needs more than one byte
+    std::string longPost;
+    for (int i = 0; i < 150; i++) {
+        longPost += "word ";
+    }
+    board.post(longPost + "haystack end");
+
+    check(contains(board.search("needle"), "Message ID: 200 "), "varint: message ID above 127 decodes");
+    check(contains(board.search("\"haystack end\""), "Message ID: 301 "), "varint: position above 127 decodes");
+    check(contains(board.search("filler 250"), "Message ID: 250 "), "varint: intersection across multi-byte deltas");
+}
+
+void testNewestResultsCap() {
+    TestBoard board;
+    for (int i = 1; i <= 45; i++) {
+        board.post("common post " + std::to_string(i));
+    }
+    std::string results = board.search("common");
+    check(contains(results, "Showing the newest 20 of 45 matches"), "cap: note gives the total");
+    check(contains(results, "Message ID: 45 ") && contains(results, "Message ID: 26 "), "cap: newest 20 are listed");
+    check(!contains(results, "Message ID: 25 "), "cap: older matches are left out");
+
+    TestBoard small;
+    small.post("common post");
+    check(!contains(small.search("common"), "Showing the newest"), "cap: no note when under the limit");
+}
+
+int main() {
+    testBareWordsAreAnded();
+    testPhrases();
+    testRepeatedTerms();
+    testUnterminatedQuote();
+    testMultiByteVarints();
+    testNewestResultsCap();
+
+    if (failures == 0) {
+        std::printf("All search index checks passed\n");
+    }
+    return failures == 0 ? 0 : 1;
+}